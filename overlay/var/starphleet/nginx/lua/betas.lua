@@ -0,0 +1,73 @@
+-- *****************************************************************************
+-- * Betas
+-- *****************************************************************************
+-- Which order a request for an order goes to instead, for users in one of
+-- its beta groups or carrying a beta_<order> cookie. starphleet-publish
+-- sets, in each location:
+--   $starphleet_beta_cookie  the name of the beta cookie for the order
+--   $starphleet_betas        'group=/order ...' from the beta orders
+-- and the groups are the maps in beta_groups/*.conf, so each lookup is a
+-- hash probe rather than a regex over the cookies. A cookie only ever picks
+-- one of the beta orders of this order, anything else is ignored.
+
+local _M = {}
+
+-- the parsed $starphleet_betas, per worker, there is one per order
+local parsed = {}
+
+-- *****************************************************************************
+-- * Helper Methods
+-- *****************************************************************************
+
+------------------------------------------------------------------------------
+-- @function groups()
+--
+-- The { group, order } pairs of a $starphleet_betas, parsed just once
+------------------------------------------------------------------------------
+local function groups(betas)
+  local pairs_of = parsed[betas]
+  if not pairs_of then
+    pairs_of = {}
+    for beta in string.gmatch(betas, "%S+") do
+      local group, order = string.match(beta, "^([^=]+)=/*(.-)/*$")
+      if group and order ~= "" then
+        pairs_of[#pairs_of + 1] = { group, order }
+      end
+    end
+    parsed[betas] = pairs_of
+  end
+  return pairs_of
+end
+
+------------------------------------------------------------------------------
+-- @function order()
+--
+-- The order this request goes to instead, or nil when it is not in a beta
+------------------------------------------------------------------------------
+function _M.order()
+  local betas = ngx.var.starphleet_betas
+  if not betas or betas == "" then
+    return nil
+  end
+  local cookie = ngx.var.starphleet_beta_cookie
+  if cookie and cookie ~= "" then
+    local sendto = ngx.var["cookie_" .. cookie]
+    if sendto and sendto ~= "" then
+      sendto = string.gsub(sendto, "^/*(.-)/*$", "%1")
+      for _, beta in ipairs(groups(betas)) do
+        if beta[2] == sendto then
+          return sendto
+        end
+      end
+    end
+  end
+  for _, beta in ipairs(groups(betas)) do
+    local group = "starphleet_beta_" .. beta[1]
+    if ngx.var[group] == "1" or ngx.var[group .. "_cookie"] == "1" then
+      return beta[2]
+    end
+  end
+  return nil
+end
+
+return _M
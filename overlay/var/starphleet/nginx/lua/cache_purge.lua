@@ -0,0 +1,120 @@
+local order = ngx.var.starphleet_cache_order
+local uri = ngx.var.starphleet_cache_uri
+local method = ngx.req.get_method()
+local root = os.getenv("STARPHLEET_PROXY_CACHE") or "/var/cache/nginx_orders"
+local ffi = require("ffi")
+
+ffi.cdef[[
+  typedef struct {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[256];
+  } starphleet_dirent;
+  void *opendir(const char *name);
+  starphleet_dirent *readdir(void *dir);
+  int closedir(void *dir);
+]]
+
+-- *****************************************************************************
+-- * Guards
+-- *****************************************************************************
+
+if method ~= "PURGE" and method ~= "DELETE" then
+  return ngx.exit(405)
+end
+
+-- order names end up in paths, nothing more
+if not string.match(order, "^[%w%-%._]+$") or string.find(order, "..", 1, true) then
+  return ngx.exit(400)
+end
+
+-- only orders publishing a zone have a cache to purge
+local zone = io.open(ngx.config.prefix() .. "cache_zones/" .. order .. ".conf")
+if not zone then
+  return ngx.exit(404)
+end
+zone:close()
+
+-- *****************************************************************************
+-- * Helper Methods
+-- *****************************************************************************
+
+------------------------------------------------------------------------------
+-- @function Where nginx keeps a key, the zones are levels=1:2 so that is
+-- the last character of the md5, then the two before it
+------------------------------------------------------------------------------
+local function _cacheFile(key)
+  local md5 = ngx.md5(key)
+  return root .. "/" .. order .. "/" .. string.sub(md5, -1) .. "/" .. string.sub(md5, -3, -2) .. "/" .. md5
+end
+
+------------------------------------------------------------------------------
+-- @function Names in a directory, without . and .., empty when it is not
+-- there. Plain readdir, so there is no shell and no lfs to go through
+------------------------------------------------------------------------------
+local function _entries(path)
+  local names = {}
+  local dir = ffi.C.opendir(path)
+  if dir == nil then
+    return names
+  end
+  local entry = ffi.C.readdir(dir)
+  while entry ~= nil do
+    local name = ffi.string(entry.d_name)
+    if name ~= "." and name ~= ".." then
+      table.insert(names, name)
+    end
+    entry = ffi.C.readdir(dir)
+  end
+  ffi.C.closedir(dir)
+  return names
+end
+
+------------------------------------------------------------------------------
+-- @function Removes every cached response of the order, the level
+-- directories stay as nginx would only make them again
+------------------------------------------------------------------------------
+local function _purgeAll()
+  local base = root .. "/" .. order
+  for _, first in ipairs(_entries(base)) do
+    for _, second in ipairs(_entries(base .. "/" .. first)) do
+      local level = base .. "/" .. first .. "/" .. second
+      for _, file in ipairs(_entries(level)) do
+        os.remove(level .. "/" .. file)
+      end
+    end
+  end
+end
+
+-- *****************************************************************************
+-- * Main
+-- *****************************************************************************
+
+------------------------------------------------------------------------------
+-- Without a path the whole cache of the order goes
+------------------------------------------------------------------------------
+if not uri or uri == "" then
+  _purgeAll()
+  return ngx.exit(204)
+end
+
+------------------------------------------------------------------------------
+-- The path and arguments make the default key, same as the cache_key
+-- published for the order. Orders with a cache_key of their own send the
+-- key as it ends up in X-Starphleet-Cache-Key
+------------------------------------------------------------------------------
+local key = ngx.req.get_headers()["X-Starphleet-Cache-Key"]
+if not key then
+  key = order .. uri
+  if ngx.var.args then
+    key = key .. "?" .. ngx.var.args
+  end
+end
+
+local ok = os.remove(_cacheFile(key))
+if not ok then
+  return ngx.exit(404)
+end
+return ngx.exit(204)
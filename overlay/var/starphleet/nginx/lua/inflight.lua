@@ -0,0 +1,52 @@
+local inflight = ngx.shared.starphleet_inflight
+
+local _M = {}
+
+-- *****************************************************************************
+-- * Helper Methods
+-- *****************************************************************************
+
+------------------------------------------------------------------------------
+-- @function begin()
+--
+-- Count a request on its way to a container, once per request however
+-- many times it passes through route.lua
+------------------------------------------------------------------------------
+function _M.begin(container)
+  if not inflight or ngx.ctx.starphleet_inflight then
+    return
+  end
+  inflight:add(container, 0)
+  inflight:incr(container, 1)
+  ngx.ctx.starphleet_inflight = container
+end
+
+------------------------------------------------------------------------------
+-- @function done()
+--
+-- The request is over, from the log phase, or it is about to be handed to
+-- another location by ngx.exec which starts the count over
+------------------------------------------------------------------------------
+function _M.done()
+  local container = ngx.ctx.starphleet_inflight
+  if not inflight or not container then
+    return
+  end
+  ngx.ctx.starphleet_inflight = nil
+  inflight:incr(container, -1)
+end
+
+------------------------------------------------------------------------------
+-- @function count()
+--
+-- Requests and websockets a container has open right now
+------------------------------------------------------------------------------
+function _M.count(container)
+  local count = inflight and inflight:get(container) or 0
+  if count < 0 then
+    return 0
+  end
+  return count
+end
+
+return _M
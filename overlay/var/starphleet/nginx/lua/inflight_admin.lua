@@ -0,0 +1,21 @@
+local inflight = ngx.shared.starphleet_inflight
+local counts = require("inflight")
+local container = ngx.var.starphleet_inflight_container
+
+-- *****************************************************************************
+-- * Main
+-- *****************************************************************************
+
+------------------------------------------------------------------------------
+-- The requests in flight to a container, just the number so drains can
+-- poll it, and without a container every one as '<container> <count>'
+------------------------------------------------------------------------------
+if container == "" then
+  for _, key in ipairs(inflight:get_keys(0)) do
+    ngx.say(key, " ", counts.count(key))
+  end
+  return ngx.exit(ngx.OK)
+end
+
+ngx.say(counts.count(container))
+return ngx.exit(ngx.OK)
@@ -3,6 +3,8 @@ require "table"
 local bit = require("bit")
 local cjson = require("cjson")
 local jwt = require("resty.jwt")
+local jwt_cache = require("jwt_cache")
+local inflight = require("inflight")
 local jwt_secret = ngx.var.jwt_secret
 local jwt_auth_site = ngx.var.jwt_auth_site
 local jwt_auth_header = ngx.var.jwt_auth_header
@@ -40,23 +42,6 @@ local function _replace(str, what, with)
   return string.gsub(str, what, with)
 end
 
-------------------------------------------------------------------------------
--- @function _fileExists(fileName)
---
--- Check if a file exists.  We use a file system check to revoke JWT tokens
--- Using the solution found here:
---   http://stackoverflow.com/a/4991602
-------------------------------------------------------------------------------
-function _fileExists(fileName)
-   local file = io.open(fileName,"r")
-   if file ~= nil then
-     io.close(file)
-     return true
-   else
-     return false
-   end
-end
-
 ------------------------------------------------------------------------------
 -- @function _sendUserToLogin()
 --
@@ -72,6 +57,7 @@ local _sendUserToLogin = function()
   ngx.req.set_header('X-Starphleet-Redirect', "true");
   ngx.req.set_header('X-Starphleet-OriginalUrl', ngx.var.request_uri);
   ngx.req.set_header('X-Starphleet-Authentic', ngx.var.authentic_token);
+  inflight.done()
   return ngx.exec(redirectUrl)
 end
 
@@ -174,10 +160,11 @@ local _isValidToken = function(token)
     --
     -- To support revocations - we will now check if a jid exists - and,
     -- if it exists then we will revoke the token if a file exists in
-    -- the revocation dir with the jid as the name of the file.  This should
-    -- later be amended to enforce jid's
+    -- the revocation dir with the jid as the name of the file, which
+    -- jwt_cache keeps in memory.  This should later be amended to
+    -- enforce jid's
     if token.payload.jid and
-    _fileExists(jwt_revocation_dir .. "/" .. token.payload.jid) then
+    jwt_cache.isRevoked(jwt_revocation_dir, token.payload.jid) then
       return false
     end
     --
@@ -205,9 +192,11 @@ end
 --      to pass the token via the URL.
 ------------------------------------------------------------------------------
 local authorizationBearerString = _getAuthorizationHeader()
-local verified_url_token = jwt:verify(jwt_secret, ngx.var.arg_jwt, 0)
+local verified_url_token = jwt_cache.verify(jwt_secret, ngx.var.arg_jwt, jwt_max_token_age_in_seconds)
+-- the cookie is signed again on every request below, so it is a new token
+-- each time and remembering it would only push the others out of the cache
 local verified_cookie_token = jwt:verify(jwt_secret, ngx.var["cookie_" .. jwt_cookie_name], 0)
-local verified_bearer_token = jwt:verify(jwt_secret, authorizationBearerString, 0)
+local verified_bearer_token = jwt_cache.verify(jwt_secret, authorizationBearerString, jwt_max_token_age_in_seconds)
 
 ------------------------------------------------------------------------------
 -- Below we follow the rules described above.  We respect a url param
@@ -0,0 +1,24 @@
+local revocations = ngx.shared.starphleet_jwt_revocations
+local jwt_cache = require("jwt_cache")
+
+-- *****************************************************************************
+-- * Main
+-- *****************************************************************************
+
+------------------------------------------------------------------------------
+-- POST reads the revocation directories again right now, say just after
+-- dropping a new revocation in, anything else lists what is revoked as
+-- '<dir> <jid>'
+------------------------------------------------------------------------------
+if ngx.req.get_method() == "POST" then
+  jwt_cache.refresh()
+  return ngx.exit(204)
+end
+
+for _, key in ipairs(revocations:get_keys(0)) do
+  local dir, jid = string.match(key, "^revoked|(.*)|([^|]*)$")
+  if dir then
+    ngx.say(dir, " ", jid)
+  end
+end
+return ngx.exit(ngx.OK)
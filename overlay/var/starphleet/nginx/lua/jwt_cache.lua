@@ -0,0 +1,164 @@
+-- *****************************************************************************
+-- * JWT Cache
+-- *****************************************************************************
+-- Tokens that verified, kept in the starphleet_jwt shared dict by a hash of
+-- the secret and token until they are too old to be any good, so the HMAC
+-- and json decode happen once per token rather than once per request.
+--
+-- Revocations are files named for the jid in a revocation directory, each
+-- directory a request asks about is read into the starphleet_jwt_revocations
+-- dict by a timer every STARPHLEET_JWT_REVOCATION_REFRESH seconds, a POST to
+-- the admin location (see jwt_admin.conf) reads them right away, so requests
+-- never touch disk. That dict is apart from the tokens and is only ever
+-- written with safe_set, so no amount of tokens can push a revocation out.
+
+local cjson = require("cjson")
+local jwt = require("resty.jwt")
+local cache = ngx.shared.starphleet_jwt
+local revocations = ngx.shared.starphleet_jwt_revocations
+local refresh_seconds = tonumber(os.getenv("STARPHLEET_JWT_REVOCATION_REFRESH")) or 5
+
+local _M = {}
+
+-- *****************************************************************************
+-- * Helper Methods
+-- *****************************************************************************
+
+------------------------------------------------------------------------------
+-- @function _readRevocations(dir)
+--
+-- Put every jid revoked in a directory into the dict, these live a couple
+-- of refreshes so a revocation that is taken away falls out on its own. A
+-- directory that does not fit is not marked loaded, which leaves requests
+-- checking its files rather than trusting a partial read
+------------------------------------------------------------------------------
+local _readRevocations = function(dir)
+  local listing = io.popen('ls -1 "' .. dir .. '" 2> /dev/null')
+  if not listing then
+    return
+  end
+  local complete = true
+  for jid in listing:lines() do
+    if not revocations:safe_set("revoked|" .. dir .. "|" .. jid, true, refresh_seconds * 2) then
+      complete = false
+    end
+  end
+  listing:close()
+  if complete then
+    revocations:safe_set("loaded|" .. dir, true, refresh_seconds * 2)
+  else
+    revocations:delete("loaded|" .. dir)
+    ngx.log(ngx.ERR, "Out of room for the jwt revocations in ", dir)
+  end
+end
+
+------------------------------------------------------------------------------
+-- @function _fileExists(fileName)
+--
+-- Only for the first look at a revocation directory, before the timer has
+-- had a chance to read it
+------------------------------------------------------------------------------
+local _fileExists = function(fileName)
+  local file = io.open(fileName, "r")
+  if file ~= nil then
+    io.close(file)
+    return true
+  end
+  return false
+end
+
+-- *****************************************************************************
+-- * Main
+-- *****************************************************************************
+
+------------------------------------------------------------------------------
+-- @function verify(secret, token, max_age)
+--
+-- The same as resty.jwt's verify with no leeway, a token that verified is
+-- remembered until it expires or is older than max_age
+------------------------------------------------------------------------------
+_M.verify = function(secret, token, max_age)
+  if not cache or not token or token == "" then
+    return jwt:verify(secret, token, 0)
+  end
+  local key = "token|" .. ngx.md5(secret .. "|" .. token)
+  local cached = cache:get(key)
+  if cached then
+    return cjson.decode(cached)
+  end
+  local verified = jwt:verify(secret, token, 0)
+  if verified["verified"] and type(verified["payload"]) == "table" then
+    local payload = verified.payload
+    local good_until = type(payload.exp) == "number" and payload.exp or 0
+    if type(payload.iat) == "number" and max_age then
+      good_until = math.min(good_until, payload.iat + max_age)
+    end
+    local ttl = good_until - ngx.time()
+    if ttl > 0 then
+      cache:set(key, cjson.encode(verified), ttl)
+    end
+  end
+  return verified
+end
+
+------------------------------------------------------------------------------
+-- @function isRevoked(dir, jid)
+--
+-- A hash lookup once the directory has been read, the first request for a
+-- directory signs it up for the timer
+------------------------------------------------------------------------------
+_M.isRevoked = function(dir, jid)
+  if not dir or dir == "" then
+    return false
+  end
+  if not revocations then
+    return _fileExists(dir .. "/" .. jid)
+  end
+  if revocations:get("loaded|" .. dir) then
+    return revocations:get("revoked|" .. dir .. "|" .. jid) == true
+  end
+  revocations:safe_set("dir|" .. dir, true)
+  return _fileExists(dir .. "/" .. jid)
+end
+
+------------------------------------------------------------------------------
+-- @function refresh()
+--
+-- Read every revocation directory we know of
+------------------------------------------------------------------------------
+_M.refresh = function()
+  for _, key in ipairs(revocations:get_keys(0)) do
+    local dir = string.match(key, "^dir|(.*)$")
+    if dir then
+      _readRevocations(dir)
+    end
+  end
+end
+
+------------------------------------------------------------------------------
+-- @function start()
+--
+-- From init_worker_by_lua, every worker has the timer going but only one of
+-- them gets to do the reading each time around
+------------------------------------------------------------------------------
+_M.start = function()
+  if not revocations then
+    return
+  end
+  local tick
+  tick = function(premature)
+    if premature then
+      return
+    end
+    if revocations:add("refreshing", true, refresh_seconds - 0.01) then
+      _M.refresh()
+    end
+    local ok, err = ngx.timer.at(refresh_seconds, tick)
+    if not ok then
+      ngx.log(ngx.ERR, "Unable to schedule jwt revocation refresh: ", err)
+    end
+  end
+  ngx.timer.at(0, tick)
+end
+
+return _M
@@ -0,0 +1 @@
+require("jwt_cache").start()
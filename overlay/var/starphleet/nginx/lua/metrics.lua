@@ -0,0 +1,146 @@
+-- *****************************************************************************
+-- * Metrics
+-- *****************************************************************************
+-- Counters kept by nginx itself in the starphleet_metrics shared dict, one
+-- response time histogram per order, plus the samples the rest of the ship
+-- leaves as files in STARPHLEET_METRICS, all served up as prometheus text at
+-- /starphleet/metrics, see metrics.conf.
+
+local metrics = ngx.shared.starphleet_metrics
+local samples_dir = os.getenv("STARPHLEET_METRICS") or "/var/run/starphleet_metrics"
+
+local _M = {
+  -- upper bounds in seconds of the upstream response time buckets
+  buckets = { 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10 }
+}
+
+-- *****************************************************************************
+-- * Helper Methods
+-- *****************************************************************************
+
+------------------------------------------------------------------------------
+-- @function incr(key, value)
+--
+-- Add to a counter, starting it at zero the first time
+------------------------------------------------------------------------------
+local incr = function(key, value)
+  local ok, err = metrics:incr(key, value)
+  if not ok and err == "not found" then
+    metrics:add(key, 0)
+    metrics:incr(key, value)
+  end
+end
+
+------------------------------------------------------------------------------
+-- @function upstream_seconds()
+--
+-- Total time spent on the upstream for this request, nginx lists each
+-- upstream tried when there were retries, nil when there was no upstream
+------------------------------------------------------------------------------
+local upstream_seconds = function()
+  local times = ngx.var.upstream_response_time
+  if not times then
+    return nil
+  end
+  local total
+  for time in string.gmatch(times, "[%d%.]+") do
+    total = (total or 0) + tonumber(time)
+  end
+  return total
+end
+
+-- *****************************************************************************
+-- * Main
+-- *****************************************************************************
+
+------------------------------------------------------------------------------
+-- @function log()
+--
+-- From log_by_lua, count the request against its order and put the upstream
+-- time in the buckets, which are cumulative the way prometheus wants them
+------------------------------------------------------------------------------
+_M.log = function()
+  local order = ngx.var.starphleet_order
+  if not metrics or not order or order == "" then
+    return
+  end
+  incr("requests|" .. order .. "|" .. ngx.var.status, 1)
+  local seconds = upstream_seconds()
+  if not seconds then
+    return
+  end
+  for _, bucket in ipairs(_M.buckets) do
+    if seconds <= bucket then
+      incr("upstream_bucket|" .. order .. "|" .. bucket, 1)
+    end
+  end
+  incr("upstream_bucket|" .. order .. "|+Inf", 1)
+  incr("upstream_sum|" .. order, seconds)
+  incr("upstream_count|" .. order, 1)
+end
+
+------------------------------------------------------------------------------
+-- @function show()
+--
+-- From content_by_lua, everything we know in prometheus text format
+------------------------------------------------------------------------------
+_M.show = function()
+  ngx.header["Content-Type"] = "text/plain; version=0.0.4"
+  local orders = {}
+  local requests = {}
+  for _, key in ipairs(metrics and metrics:get_keys(0) or {}) do
+    local kind, rest = string.match(key, "^([%w_]+)|(.*)$")
+    if kind == "requests" then
+      local order, status = string.match(rest, "^(.*)|([^|]*)$")
+      table.insert(requests, { order = order, status = status, count = metrics:get(key) })
+    elseif kind == "upstream_sum" then
+      orders[rest] = true
+    end
+  end
+
+  ngx.say("# TYPE starphleet_requests_total counter")
+  for _, request in ipairs(requests) do
+    ngx.say('starphleet_requests_total{order="', request.order, '",status="', request.status, '"} ', request.count)
+  end
+
+  ngx.say("# TYPE starphleet_upstream_response_seconds histogram")
+  for order, _ in pairs(orders) do
+    for _, bucket in ipairs(_M.buckets) do
+      ngx.say('starphleet_upstream_response_seconds_bucket{order="', order, '",le="', bucket, '"} ',
+        metrics:get("upstream_bucket|" .. order .. "|" .. bucket) or 0)
+    end
+    ngx.say('starphleet_upstream_response_seconds_bucket{order="', order, '",le="+Inf"} ',
+      metrics:get("upstream_bucket|" .. order .. "|+Inf") or 0)
+    ngx.say('starphleet_upstream_response_seconds_sum{order="', order, '"} ',
+      metrics:get("upstream_sum|" .. order) or 0)
+    ngx.say('starphleet_upstream_response_seconds_count{order="', order, '"} ',
+      metrics:get("upstream_count|" .. order) or 0)
+  end
+
+  ----------------------------------------------------------------------------
+  -- The samples from the rest of the ship are all gauges, the files sort
+  -- by name so each metric comes out as one group
+  ----------------------------------------------------------------------------
+  local listing = io.popen('ls "' .. samples_dir .. '"/*.prom 2> /dev/null')
+  if listing then
+    local last_name
+    for path in listing:lines() do
+      local file = io.open(path, "r")
+      if file then
+        local sample = file:read("*l")
+        file:close()
+        local name = sample and string.match(sample, "^([%w_:]+)")
+        if name then
+          if name ~= last_name then
+            ngx.say("# TYPE ", name, " gauge")
+            last_name = name
+          end
+          ngx.say(sample)
+        end
+      end
+    end
+    listing:close()
+  end
+end
+
+return _M
@@ -0,0 +1,3 @@
+require("metrics").log()
+-- the request is no longer in flight to its container, for drains
+require("inflight").done()
@@ -0,0 +1 @@
+require("metrics").show()
@@ -0,0 +1,83 @@
+local notify_dir = os.getenv("STARPHLEET_NOTIFY")
+local notify_token = os.getenv("STARPHLEET_NOTIFY_TOKEN")
+local order = ngx.var.starphleet_notify_order
+
+-- *****************************************************************************
+-- * Guards
+-- *****************************************************************************
+
+if not notify_dir or notify_dir == "" then
+  ngx.log(ngx.ERR, "Error processing notification. Missing STARPHLEET_NOTIFY configuration value")
+  return ngx.exit(500)
+end
+
+-- *****************************************************************************
+-- * Helper Methods
+-- *****************************************************************************
+
+------------------------------------------------------------------------------
+-- @function _isPrivateAddress(address)
+--
+-- Webhooks from the ship, the containers and the private networks are
+-- trusted the same way published services trust them (see the 'allow'
+-- rules in starphleet-publish)
+------------------------------------------------------------------------------
+local _isPrivateAddress = function(address)
+  local a, b = string.match(address or "", "^(%d+)%.(%d+)%.")
+  a = tonumber(a)
+  b = tonumber(b)
+  if a == 127 or a == 10 then
+    return true
+  end
+  if a == 192 and b == 168 then
+    return true
+  end
+  if a == 172 and b and b >= 16 and b <= 31 then
+    return true
+  end
+  return false
+end
+
+------------------------------------------------------------------------------
+-- @function _hasToken()
+--
+-- The token can come along as ?token= or as a header, whichever is easier
+-- to configure on the webhook sending side
+------------------------------------------------------------------------------
+local _hasToken = function()
+  if not notify_token or notify_token == "" then
+    return false
+  end
+  return ngx.var.arg_token == notify_token or
+    ngx.var.http_x_starphleet_notify_token == notify_token
+end
+
+-- *****************************************************************************
+-- * Main
+-- *****************************************************************************
+
+if not _hasToken() and not _isPrivateAddress(ngx.var.remote_addr) then
+  return ngx.exit(403)
+end
+
+-- order names are paths in the headquarters, nothing more
+if not string.match(order, "^[%w%-%._/]+$") or string.find(order, "..", 1, true) then
+  return ngx.exit(400)
+end
+
+------------------------------------------------------------------------------
+-- The orders monitor is watching this directory, it picks up the file,
+-- removes it and checks the order.  The file name is the order with
+-- / encoded, to match starphleet-notify
+------------------------------------------------------------------------------
+local file = io.open(notify_dir .. "/" .. (string.gsub(order, "/", "%%2F")), "w")
+if not file then
+  ngx.log(ngx.ERR, "Unable to write notification for ", order)
+  return ngx.exit(500)
+end
+file:write(ngx.time(), "\n")
+file:close()
+
+ngx.status = 202
+ngx.say("notified ", order)
+return ngx.exit(ngx.OK)
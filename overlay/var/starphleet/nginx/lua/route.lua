@@ -0,0 +1,43 @@
+local routes = ngx.shared.starphleet_routes
+local upstreams = require("upstreams")
+local inflight = require("inflight")
+local betas = require("betas")
+local order = ngx.var.starphleet_order
+
+-- *****************************************************************************
+-- * Main
+-- *****************************************************************************
+
+------------------------------------------------------------------------------
+-- Beta users are sent on to the location of the beta order, internally, so
+-- that the access rules of the beta order apply to them as well. The uri is
+-- already without the order by now
+------------------------------------------------------------------------------
+local beta = betas.order()
+if beta then
+  return ngx.exec("/" .. beta .. ngx.var.uri, ngx.var.args)
+end
+
+------------------------------------------------------------------------------
+-- Look up the container serving this order, each request, so that pointing
+-- an order at a new container takes effect right away with no reload
+------------------------------------------------------------------------------
+local route = routes:get(order)
+if not route then
+  ngx.log(ngx.ERR, "No route to a container for order ", order)
+  return ngx.exit(503)
+end
+
+------------------------------------------------------------------------------
+-- Go through the connection pool for the container when this configuration
+-- has one, a container that just came online is proxied to directly until
+-- the next reload picks up its upstream
+------------------------------------------------------------------------------
+local container, address = string.match(route, "^(%S+) (%S+)$")
+ngx.var.starphleet_container = container
+inflight.begin(container)
+if upstreams.names[container] then
+  ngx.var.starphleet_upstream = container
+else
+  ngx.var.starphleet_upstream = address
+end
@@ -0,0 +1,49 @@
+local routes = ngx.shared.starphleet_routes
+local order = ngx.var.starphleet_route_order
+local method = ngx.req.get_method()
+
+-- *****************************************************************************
+-- * Main
+-- *****************************************************************************
+
+------------------------------------------------------------------------------
+-- Without an order, list the whole table in the same format as the
+-- routes file
+------------------------------------------------------------------------------
+if order == "" then
+  for _, key in ipairs(routes:get_keys(0)) do
+    ngx.say(key, " ", routes:get(key))
+  end
+  return ngx.exit(ngx.OK)
+end
+
+if method == "GET" then
+  local route = routes:get(order)
+  if not route then
+    return ngx.exit(404)
+  end
+  ngx.say(order, " ", route)
+  return ngx.exit(ngx.OK)
+end
+
+if method == "DELETE" then
+  routes:delete(order)
+  return ngx.exit(204)
+end
+
+------------------------------------------------------------------------------
+-- PUT or POST '<container> <address>' points the order at a container
+------------------------------------------------------------------------------
+ngx.req.read_body()
+local container, address = string.match(ngx.req.get_body_data() or "", "^%s*(%S+)%s+(%S+)%s*$")
+if not container then
+  return ngx.exit(400)
+end
+local ok, err = routes:set(order, container .. " " .. address)
+if not ok then
+  ngx.log(ngx.ERR, "Unable to set route for ", order, ": ", err)
+  return ngx.exit(500)
+end
+ngx.status = 200
+ngx.say(order, " ", container, " ", address)
+return ngx.exit(ngx.OK)
@@ -0,0 +1,43 @@
+local routes = ngx.shared.starphleet_routes
+local routes_file = os.getenv("STARPHLEET_ROUTES")
+local upstreams = require("upstreams")
+
+upstreams.load("/var/starphleet/nginx/upstreams")
+
+-- *****************************************************************************
+-- * Guards
+-- *****************************************************************************
+
+if not routes or not routes_file or routes_file == "" then
+  return
+end
+
+-- *****************************************************************************
+-- * Main
+-- *****************************************************************************
+
+------------------------------------------------------------------------------
+-- Runs in the master when nginx starts or reloads.  The routes file is the
+-- durable copy of the table starphleet-route keeps, one line per order of
+-- '<order> <container> <address>', the shared dict survives reloads so we
+-- only set what is there and drop what is not, never clear it out from
+-- under requests in flight
+------------------------------------------------------------------------------
+local file = io.open(routes_file, "r")
+if not file then
+  return
+end
+local seen = {}
+for line in file:lines() do
+  local order, container, address = string.match(line, "^(%S+)%s+(%S+)%s+(%S+)%s*$")
+  if order then
+    routes:set(order, container .. " " .. address)
+    seen[order] = true
+  end
+end
+file:close()
+for _, order in ipairs(routes:get_keys(0)) do
+  if not seen[order] then
+    routes:delete(order)
+  end
+end
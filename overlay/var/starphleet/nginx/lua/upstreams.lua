@@ -0,0 +1,33 @@
+-- *****************************************************************************
+-- * Upstreams
+-- *****************************************************************************
+-- The names of the upstream connection pools this nginx configuration has,
+-- one per container, see upstreams/*.conf written by starphleet-publish.
+-- Loaded once in init_by_lua, so each reload sees its own set.
+
+local _M = { names = {} }
+
+------------------------------------------------------------------------------
+-- @function load(dir)
+--
+-- Pick the upstream names out of every config file in dir
+------------------------------------------------------------------------------
+_M.load = function(dir)
+  local names = {}
+  local listing = io.popen('ls "' .. dir .. '"/*.conf 2> /dev/null')
+  if listing then
+    for path in listing:lines() do
+      local file = io.open(path, "r")
+      if file then
+        for name in string.gmatch(file:read("*a"), "upstream%s+([%w%-%._]+)%s*{") do
+          names[name] = true
+        end
+        file:close()
+      end
+    end
+    listing:close()
+  end
+  _M.names = names
+end
+
+return _M